@@ -0,0 +1,275 @@
+#include "AccMapTables.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool AccMapTable::Init(const char* base, uint64_t size, const AccMapTableHeader* header)
+{
+
+  mHeader = header;
+  mNDims = header->nDims;
+  if (mNDims < 1 || mNDims > accMapMaxDims || header->type >= kNTypes) {
+    printf("Table %s: bad header\n", header->name);
+    return false;
+  }
+
+  uint64_t offset = header->offsetAxes;
+  uint64_t nBinsTotal = 1;
+  for (int iDim = 0; iDim < mNDims; iDim++) {
+    if (offset + sizeof(int64_t) > size) {
+      printf("Table %s: axis %d beyond the end of the file\n", header->name, iDim);
+      return false;
+    }
+    int64_t nBins = *(const int64_t*)(base + offset);
+    offset += sizeof(int64_t);
+    if (nBins < 1 || offset + (nBins + 1) * sizeof(double) > size) {
+      printf("Table %s: bad axis %d\n", header->name, iDim);
+      return false;
+    }
+    mNBins[iDim] = nBins;
+    mEdges[iDim] = (const double*)(base + offset);
+    offset += (nBins + 1) * sizeof(double);
+    nBinsTotal *= nBins + 2;
+
+    // uniform axes are looked up without a binary search
+    double width = (mEdges[iDim][nBins] - mEdges[iDim][0]) / nBins;
+    mIsUniform[iDim] = true;
+    for (int iBin = 0; iBin <= nBins; iBin++) {
+      if (fabs(mEdges[iDim][iBin] - (mEdges[iDim][0] + iBin * width)) > 1.e-9 * fabs(width))
+        mIsUniform[iDim] = false;
+    }
+  }
+
+  uint64_t sizeEntry = (header->type == kFlags) ? sizeof(uint8_t) : (header->type == kValues ? sizeof(float) : sizeof(uint64_t));
+  if (header->type != kSparseFlags && header->nEntries != nBinsTotal) {
+    printf("Table %s: %llu entries for %llu bins\n", header->name, (unsigned long long)header->nEntries, (unsigned long long)nBinsTotal);
+    return false;
+  }
+  if (header->offsetData + header->nEntries * sizeEntry > size) {
+    printf("Table %s: data beyond the end of the file\n", header->name);
+    return false;
+  }
+  mData = base + header->offsetData;
+
+  return true;
+}
+
+//==========================================================================================================
+
+int AccMapTable::FindBin(int dim, double x) const
+{
+
+  const double* edges = mEdges[dim];
+  int nBins = mNBins[dim];
+  if (x < edges[0])
+    return 0;
+  if (!(x < edges[nBins]))
+    return nBins + 1;
+  if (mIsUniform[dim])
+    return std::min(int((x - edges[0]) / (edges[nBins] - edges[0]) * nBins), nBins - 1) + 1;
+  return int(std::upper_bound(edges, edges + nBins + 1, x) - edges);
+}
+
+//==========================================================================================================
+
+double AccMapTable::GetValue(const double* x) const
+{
+
+  int bins[accMapMaxDims];
+  for (int iDim = 0; iDim < mNDims; iDim++)
+    bins[iDim] = FindBin(iDim, x[iDim]);
+  return GetValueAt(bins);
+}
+
+//==========================================================================================================
+
+double AccMapTable::GetValueAt(const int* bins) const
+{
+
+  uint64_t index = 0;
+  for (int iDim = 0; iDim < mNDims; iDim++)
+    index = index * (mNBins[iDim] + 2) + bins[iDim];
+
+  switch (mHeader->type) {
+    case kFlags:
+      return ((const uint8_t*)mData)[index];
+    case kValues:
+      return ((const float*)mData)[index];
+    case kSparseFlags: {
+      const uint64_t* first = (const uint64_t*)mData;
+      const uint64_t* last = first + mHeader->nEntries;
+      return std::binary_search(first, last, index) ? 1 : 0;
+    }
+  }
+  return 0;
+}
+
+//==========================================================================================================
+
+uint64_t AccMapTable::GetNBinsTotal(const vector<vector<double>>& edges)
+{
+
+  uint64_t nBinsTotal = 1;
+  for (const auto& edgesDim : edges)
+    nBinsTotal *= edgesDim.size() + 1;
+  return nBinsTotal;
+}
+
+//==========================================================================================================
+
+AccMapTables::~AccMapTables()
+{
+
+  if (mMap)
+    munmap(mMap, mSize);
+}
+
+//==========================================================================================================
+
+bool AccMapTables::Open(const char* nameFile)
+{
+
+  int fd = open(nameFile, O_RDONLY);
+  if (fd < 0) {
+    printf("File %s not found\n", nameFile);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size < (off_t)sizeof(AccMapFileHeader)) {
+    printf("File %s is too short\n", nameFile);
+    close(fd);
+    return false;
+  }
+  mSize = st.st_size;
+  mMap = mmap(0, mSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mMap == MAP_FAILED) {
+    printf("File %s could not be mapped\n", nameFile);
+    mMap = 0;
+    return false;
+  }
+
+  const char* base = (const char*)mMap;
+  const AccMapFileHeader* header = (const AccMapFileHeader*)base;
+  if (memcmp(header->magic, accMapMagic, sizeof(accMapMagic))) {
+    printf("File %s is not an acceptance map table file\n", nameFile);
+    return false;
+  }
+  if (header->version != accMapVersion) {
+    printf("File %s has version %u, version %u expected\n", nameFile, header->version, accMapVersion);
+    return false;
+  }
+  if (sizeof(AccMapFileHeader) + header->nTables * sizeof(AccMapTableHeader) > mSize) {
+    printf("File %s: table headers beyond the end of the file\n", nameFile);
+    return false;
+  }
+
+  const AccMapTableHeader* tableHeaders = (const AccMapTableHeader*)(base + sizeof(AccMapFileHeader));
+  mTables.resize(header->nTables);
+  for (uint32_t iTable = 0; iTable < header->nTables; iTable++) {
+    if (!mTables[iTable].Init(base, mSize, &tableHeaders[iTable])) {
+      mTables.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//==========================================================================================================
+
+const AccMapTable* AccMapTables::Get(const char* name) const
+{
+
+  for (const auto& table : mTables) {
+    if (!strncmp(table.GetName(), name, sizeof(AccMapTableHeader::name)))
+      return &table;
+  }
+  return 0;
+}
+
+//==========================================================================================================
+
+bool AccMapTables::Write(const char* nameFile, const vector<TableData>& tables)
+{
+
+  auto align = [](uint64_t offset) { return (offset + 7) / 8 * 8; };
+
+  // compute the layout
+  vector<AccMapTableHeader> headers(tables.size());
+  uint64_t offset = align(sizeof(AccMapFileHeader) + tables.size() * sizeof(AccMapTableHeader));
+  for (unsigned int iTable = 0; iTable < tables.size(); iTable++) {
+    const TableData& table = tables[iTable];
+    AccMapTableHeader& header = headers[iTable];
+    memset(&header, 0, sizeof(header));
+    if (table.name.size() >= sizeof(header.name) || table.edges.empty() || table.edges.size() > accMapMaxDims) {
+      printf("Table %s cannot be written\n", table.name.c_str());
+      return false;
+    }
+    strncpy(header.name, table.name.c_str(), sizeof(header.name) - 1);
+    header.type = table.type;
+    header.nDims = table.edges.size();
+    header.nEntries = (table.type == AccMapTable::kFlags) ? table.flags.size() : (table.type == AccMapTable::kValues ? table.values.size() : table.bins.size());
+    if (table.type != AccMapTable::kSparseFlags && header.nEntries != AccMapTable::GetNBinsTotal(table.edges)) {
+      printf("Table %s: %llu entries for %llu bins\n", table.name.c_str(), (unsigned long long)header.nEntries, (unsigned long long)AccMapTable::GetNBinsTotal(table.edges));
+      return false;
+    }
+    header.offsetAxes = offset;
+    for (const auto& edges : table.edges)
+      offset += sizeof(int64_t) + edges.size() * sizeof(double);
+    header.offsetData = offset = align(offset);
+    uint64_t sizeEntry = (table.type == AccMapTable::kFlags) ? sizeof(uint8_t) : (table.type == AccMapTable::kValues ? sizeof(float) : sizeof(uint64_t));
+    offset = align(offset + header.nEntries * sizeEntry);
+  }
+
+  FILE* file = fopen(nameFile, "wb");
+  if (!file) {
+    printf("File %s cannot be created\n", nameFile);
+    return false;
+  }
+
+  auto pad = [&](uint64_t target) {
+    for (long pos = ftell(file); (uint64_t)pos < target; pos++)
+      fputc(0, file);
+  };
+
+  AccMapFileHeader fileHeader;
+  memset(&fileHeader, 0, sizeof(fileHeader));
+  memcpy(fileHeader.magic, accMapMagic, sizeof(accMapMagic));
+  fileHeader.version = accMapVersion;
+  fileHeader.nTables = tables.size();
+  fwrite(&fileHeader, sizeof(fileHeader), 1, file);
+  if (!headers.empty())
+    fwrite(headers.data(), sizeof(AccMapTableHeader), headers.size(), file);
+
+  for (unsigned int iTable = 0; iTable < tables.size(); iTable++) {
+    const TableData& table = tables[iTable];
+    pad(headers[iTable].offsetAxes);
+    for (const auto& edges : table.edges) {
+      int64_t nBins = edges.size() - 1;
+      fwrite(&nBins, sizeof(nBins), 1, file);
+      fwrite(edges.data(), sizeof(double), edges.size(), file);
+    }
+    pad(headers[iTable].offsetData);
+    if (table.type == AccMapTable::kFlags)
+      fwrite(table.flags.data(), sizeof(uint8_t), table.flags.size(), file);
+    else if (table.type == AccMapTable::kValues)
+      fwrite(table.values.data(), sizeof(float), table.values.size(), file);
+    else
+      fwrite(table.bins.data(), sizeof(uint64_t), table.bins.size(), file);
+  }
+  pad(offset);
+
+  bool good = !ferror(file);
+  fclose(file);
+  if (!good)
+    printf("Error while writing file %s\n", nameFile);
+  return good;
+}
+
+//==========================================================================================================
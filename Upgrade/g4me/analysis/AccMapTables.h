@@ -0,0 +1,104 @@
+#ifndef AccMapTables_h
+#define AccMapTables_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Compact binary lookup tables for the acceptance maps, written by BuildAccMapTables.C.
+// The file is memory-mapped read-only at startup, so no histogram is created, projected or cloned,
+// and the processes running on the same node share one copy of the tables in the page cache.
+//
+// File layout (native byte order, all offsets from the beginning of the file, 8-byte aligned):
+//   AccMapFileHeader
+//   AccMapTableHeader[nTables]
+//   for each table: axes (per dimension: int64 nBins, double edges[nBins + 1]), then data
+// Data types: dense array of uint8 flags, dense array of float values, sorted list of the uint64 global indices of the filled bins.
+// Bins are numbered as in ROOT (0: underflow, 1..nBins, nBins + 1: overflow) and the data include the underflow and overflow bins,
+// so that coordinates outside the axis ranges give the same results as the histograms the tables are made from.
+// Global index of a bin: ((i0 * (n1 + 2) + i1) * (n2 + 2) + i2) ..., with the first axis varying slowest.
+
+const char accMapMagic[8] = {'A', 'C', 'C', 'M', 'A', 'P', '\0', '\0'};
+const uint32_t accMapVersion = 2;
+const int accMapMaxDims = 4;
+
+struct AccMapFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t nTables;
+};
+
+struct AccMapTableHeader {
+  char name[64];
+  uint32_t type;
+  uint32_t nDims;
+  uint64_t nEntries; // number of elements in the data array
+  uint64_t offsetAxes;
+  uint64_t offsetData;
+};
+
+class AccMapTable
+{
+
+ public:
+  enum { kFlags,
+         kValues,
+         kSparseFlags,
+         kNTypes };
+
+  AccMapTable() = default;
+  ~AccMapTable() = default;
+
+  bool Init(const char* base, uint64_t size, const AccMapTableHeader* header);
+  const char* GetName() const { return mHeader->name; }
+  int GetNDims() const { return mNDims; }
+  int GetNBins(int dim) const { return mNBins[dim]; }
+  double GetXmin(int dim) const { return mEdges[dim][0]; }
+  double GetXmax(int dim) const { return mEdges[dim][mNBins[dim]]; }
+  double GetBinCenter(int dim, int bin) const { return 0.5 * (mEdges[dim][bin - 1] + mEdges[dim][bin]); } // 1 <= bin <= nBins
+
+  int FindBin(int dim, double x) const; // as TAxis::FindBin: 0 below the axis range, nBins + 1 above it (and for NaN)
+  double GetValue(const double* x) const;
+  double GetValueAt(const int* bins) const;
+  static uint64_t GetNBinsTotal(const vector<vector<double>>& edges); // including the underflow and overflow bins
+
+ protected:
+  const AccMapTableHeader* mHeader = 0;
+  int mNDims = 0;
+  int mNBins[accMapMaxDims] = {0};
+  const double* mEdges[accMapMaxDims] = {0};
+  bool mIsUniform[accMapMaxDims] = {false};
+  const void* mData = 0;
+};
+
+class AccMapTables
+{
+
+ public:
+  AccMapTables() = default;
+  ~AccMapTables();
+
+  bool Open(const char* nameFile);
+  const AccMapTable* Get(const char* name) const;
+  int GetNTables() const { return mTables.size(); }
+
+  // tables to be written
+  struct TableData {
+    string name;
+    uint32_t type;
+    vector<vector<double>> edges; // per dimension
+    vector<uint8_t> flags;
+    vector<float> values;
+    vector<uint64_t> bins;
+  };
+  static bool Write(const char* nameFile, const vector<TableData>& tables);
+
+ protected:
+  void* mMap = 0;
+  uint64_t mSize = 0;
+  vector<AccMapTable> mTables;
+};
+
+#endif
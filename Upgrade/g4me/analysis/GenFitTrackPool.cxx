@@ -0,0 +1,64 @@
+#include "GenFitTrackPool.h"
+#include <AbsTrackRep.h>
+#include <RKTrackRep.h>
+
+GenFitTrackPool::GenFitTrackPool()
+{
+
+  mNAllocated = 0;
+}
+
+//==========================================================================================================
+
+GenFitTrackPool::~GenFitTrackPool()
+{
+
+  for (auto& freeTracks : mFreeTracks) {
+    for (auto track : freeTracks.second)
+      delete track;
+  }
+}
+
+//==========================================================================================================
+
+genfit::Track* GenFitTrackPool::Get(const genfit::TrackCand& cand, const genfit::MeasurementFactory<genfit::AbsMeasurement>& factory)
+{
+
+  int pdg = cand.getPdgCode();
+  vector<genfit::Track*>& freeTracks = mFreeTracks[pdg];
+
+  if (freeTracks.empty()) {
+    mNAllocated++;
+    return new genfit::Track(cand, factory, new genfit::RKTrackRep(pdg));
+  }
+
+  genfit::Track* track = freeTracks.back();
+  freeTracks.pop_back();
+
+  // the fitter infos of the previous fit are deleted with the track points, the fit status is replaced by the fitter
+  while (track->getNumPoints() > 0)
+    track->deleteTrackPoint(-1);
+
+  vector<genfit::AbsMeasurement*> measurements = factory.createMany(cand);
+  for (auto measurement : measurements)
+    track->insertMeasurement(measurement);
+
+  track->setStateSeed(cand.getStateSeed());
+  track->setCovSeed(cand.getCovSeed());
+  track->setTimeSeed(cand.getTimeSeed());
+  track->setMcTrackId(cand.getMcTrackId());
+
+  return track;
+}
+
+//==========================================================================================================
+
+void GenFitTrackPool::Release(genfit::Track* track)
+{
+
+  if (!track)
+    return;
+  mFreeTracks[track->getCardinalRep()->getPDG()].push_back(track);
+}
+
+//==========================================================================================================
@@ -0,0 +1,34 @@
+#ifndef GenFitTrackPool_h
+#define GenFitTrackPool_h
+
+#include <AbsMeasurement.h>
+#include <MeasurementFactory.h>
+#include <Track.h>
+#include <TrackCand.h>
+
+#include <map>
+#include <vector>
+
+using namespace std;
+
+// Pool of genfit::Track objects, each with its RKTrackRep, recycled between the fits of the track candidates.
+// A track taken with Get is refilled with the measurements and the seed of the candidate and has to be given back with Release.
+// New tracks and reps are allocated only when no free track with the PDG code of the candidate is left.
+
+class GenFitTrackPool
+{
+
+ public:
+  GenFitTrackPool();
+  ~GenFitTrackPool();
+
+  genfit::Track* Get(const genfit::TrackCand& cand, const genfit::MeasurementFactory<genfit::AbsMeasurement>& factory);
+  void Release(genfit::Track* track);
+  int GetNAllocated() { return mNAllocated; }
+
+ protected:
+  map<int, vector<genfit::Track*>> mFreeTracks; // free tracks, by PDG code of their rep
+  int mNAllocated;
+};
+
+#endif
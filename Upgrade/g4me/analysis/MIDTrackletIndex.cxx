@@ -0,0 +1,94 @@
+#include "MIDTrackletIndex.h"
+#include "TClonesArray.h"
+#include "TVector3.h"
+#include "TMath.h"
+#include <algorithm>
+
+MIDTrackletIndex::MIDTrackletIndex(double searchSpotRadius, double etaMin, double etaMax)
+{
+
+  mEtaMin = etaMin;
+  mNEtaBins = TMath::Max(1, TMath::FloorNint((etaMax - etaMin) / searchSpotRadius));
+  mEtaBinWidth = (etaMax - etaMin) / mNEtaBins;
+  mNPhiBins = TMath::Max(1, TMath::FloorNint(TMath::TwoPi() / searchSpotRadius));
+  mPhiBinWidth = TMath::TwoPi() / mNPhiBins;
+
+  mCells.resize(mNEtaBins * mNPhiBins);
+  mNIndexedTracklets = 0;
+}
+
+//==========================================================================================================
+
+int MIDTrackletIndex::GetEtaBin(double eta)
+{
+
+  // tracklets outside the eta range are kept in the edge cells
+  int iEta = TMath::FloorNint((eta - mEtaMin) / mEtaBinWidth);
+  return TMath::Min(TMath::Max(iEta, 0), mNEtaBins - 1);
+}
+
+//==========================================================================================================
+
+int MIDTrackletIndex::GetPhiBin(double phi)
+{
+
+  int iPhi = TMath::FloorNint((phi + TMath::Pi()) / mPhiBinWidth);
+  return ((iPhi % mNPhiBins) + mNPhiBins) % mNPhiBins;
+}
+
+//==========================================================================================================
+
+void MIDTrackletIndex::Fill(TClonesArray* trackCandidatesHitPosMID)
+{
+
+  for (auto& cell : mCells)
+    cell.clear();
+  mNIndexedTracklets = 0;
+
+  int nTrackletsMID = trackCandidatesHitPosMID->GetEntries();
+
+  for (int iTrackletMID = 0; iTrackletMID < nTrackletsMID; iTrackletMID++) {
+
+    TClonesArray* hitsPosMID = (TClonesArray*)trackCandidatesHitPosMID->At(iTrackletMID);
+    if (hitsPosMID->GetEntries() != 2)
+      continue;
+
+    // the search spot is evaluated with the hit in the 1st MID layer, i.e. the one with the smaller radius
+    TVector3* posHitLayer1 = (TVector3*)hitsPosMID->At(0);
+    TVector3* posHitLayer2 = (TVector3*)hitsPosMID->At(1);
+    if (posHitLayer1->Perp() > posHitLayer2->Perp())
+      posHitLayer1 = posHitLayer2;
+
+    mCells[GetEtaBin(posHitLayer1->Eta()) * mNPhiBins + GetPhiBin(posHitLayer1->Phi())].push_back(iTrackletMID);
+    mNIndexedTracklets++;
+  }
+}
+
+//==========================================================================================================
+
+void MIDTrackletIndex::GetCandidates(TVector3 posITStrackLayer1, vector<int>& candidates)
+{
+
+  candidates.clear();
+
+  int iEtaITS = GetEtaBin(posITStrackLayer1.Eta());
+  int iPhiITS = GetPhiBin(posITStrackLayer1.Phi());
+
+  for (int iEta = TMath::Max(iEtaITS - 1, 0); iEta <= TMath::Min(iEtaITS + 1, mNEtaBins - 1); iEta++) {
+    for (int iPhiShift = -1; iPhiShift <= 1; iPhiShift++) {
+      // avoid visiting a cell twice if there are less than 3 phi bins
+      if (iPhiShift && TMath::Abs(iPhiShift) >= mNPhiBins)
+        continue;
+      if (iPhiShift == 1 && mNPhiBins == 2)
+        continue;
+      int iPhi = ((iPhiITS + iPhiShift) % mNPhiBins + mNPhiBins) % mNPhiBins;
+      const vector<int>& cell = mCells[iEta * mNPhiBins + iPhi];
+      candidates.insert(candidates.end(), cell.begin(), cell.end());
+    }
+  }
+
+  // keep the order of the brute-force loop over the tracklets
+  sort(candidates.begin(), candidates.end());
+}
+
+//==========================================================================================================
@@ -0,0 +1,39 @@
+#ifndef MIDTrackletIndex_h
+#define MIDTrackletIndex_h
+
+#include "TClonesArray.h"
+#include "TVector3.h"
+#include "TMath.h"
+#include <vector>
+
+using namespace std;
+
+// Per-event (eta, phi) grid of the MID tracklets, indexed by the position of their hit in the 1st MID layer.
+// The cells are at least as large as the search spot, so that all the tracklets within the search spot of an ITS track
+// are found in the 3x3 cells around it. The candidates still have to be checked with MIDTrackletSelector.
+
+class MIDTrackletIndex
+{
+
+ public:
+  MIDTrackletIndex(double searchSpotRadius = 0.2, double etaMin = -1.65, double etaMax = 1.65);
+  ~MIDTrackletIndex() = default;
+
+  void Fill(TClonesArray* trackCandidatesHitPosMID);
+  void GetCandidates(TVector3 posITStrackLayer1, vector<int>& candidates);
+  int GetNIndexedTracklets() { return mNIndexedTracklets; }
+
+ protected:
+  int GetEtaBin(double eta);
+  int GetPhiBin(double phi);
+
+  vector<vector<int>> mCells; // tracklet indices, cell index = iEta * mNPhiBins + iPhi
+  int mNEtaBins;
+  int mNPhiBins;
+  double mEtaMin;
+  double mEtaBinWidth;
+  double mPhiBinWidth;
+  int mNIndexedTracklets;
+};
+
+#endif
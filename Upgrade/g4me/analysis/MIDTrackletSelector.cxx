@@ -5,6 +5,7 @@
 #include "TFile.h"
 #include "TVector3.h"
 #include "TMath.h"
+#include "TString.h"
 
 MIDTrackletSelector::MIDTrackletSelector()
 {
@@ -16,7 +17,15 @@ MIDTrackletSelector::MIDTrackletSelector()
   for (int iCharge = 0; iCharge < kNChargeOptions; iCharge++)
     mTrackletAcc4D[iCharge] = NULL;
 
+  mTables = NULL;
+  mTableAcc2D = NULL;
+  mTableAcc3D = NULL;
+
+  for (int iCharge = 0; iCharge < kNChargeOptions; iCharge++)
+    mTableAcc4D[iCharge] = NULL;
+
   mIsSelectorSetup = kFALSE;
+  mSearchSpotRadius = 0.2;
 }
 
 //==========================================================================================================
@@ -24,6 +33,9 @@ MIDTrackletSelector::MIDTrackletSelector()
 bool MIDTrackletSelector::Setup(const Char_t* nameInputFile = "muonTrackletAcceptance.root")
 {
 
+  if (TString(nameInputFile).EndsWith(".accmap"))
+    return SetupFromTables(nameInputFile);
+
   mInputFile = new TFile(nameInputFile);
   if (!mInputFile) {
     printf("File %s not found\n", nameInputFile);
@@ -62,6 +74,44 @@ bool MIDTrackletSelector::Setup(const Char_t* nameInputFile = "muonTrackletAccep
   return kTRUE;
 }
 
+//==========================================================================================================
+
+bool MIDTrackletSelector::SetupFromTables(const Char_t* nameInputFile = "muonAcceptance.accmap")
+{
+
+  mTables = new AccMapTables();
+  if (!mTables->Open(nameInputFile)) {
+    delete mTables;
+    mTables = NULL;
+    return kFALSE;
+  }
+
+  const char* nameTable4D[kNChargeOptions] = {"trackletAcceptanceMuMinus", "trackletAcceptanceMuPlus", "trackletAcceptanceAllMuons"};
+  for (int iCharge = 0; iCharge < kNChargeOptions; iCharge++) {
+    mTableAcc4D[iCharge] = mTables->Get(nameTable4D[iCharge]);
+    if (!mTableAcc4D[iCharge] || mTableAcc4D[iCharge]->GetNDims() != 4) {
+      printf("Table <%s> not found in file %s, quitting\n", nameTable4D[iCharge], nameInputFile);
+      return kFALSE;
+    }
+  }
+
+  mTableAcc3D = mTables->Get("trackletAcc3D");
+  mTableAcc2D = mTables->Get("trackletAcc2D");
+  if (!mTableAcc3D || !mTableAcc2D) {
+    printf("Tables <trackletAcc3D> and <trackletAcc2D> not found in file %s, quitting\n", nameInputFile);
+    return kFALSE;
+  }
+
+  mEtaMax = mTableAcc4D[kAllMuons]->GetXmax(2);
+  mMomMax = mTableAcc4D[kAllMuons]->GetBinCenter(3, mTableAcc4D[kAllMuons]->GetNBins(3));
+  mMomMin = mTableAcc4D[kAllMuons]->GetBinCenter(3, 1);
+
+  mIsSelectorSetup = kTRUE;
+
+  printf("Setup of MIDTrackletSelector from tables successfully completed\n");
+  return kTRUE;
+}
+
 //====================================================================================================================================================
 
 bool MIDTrackletSelector::IsMIDTrackletSelected(TVector3 posHitLayer1, TVector3 posHitLayer2, bool evalEta = kFALSE)
@@ -85,9 +135,18 @@ bool MIDTrackletSelector::IsMIDTrackletSelected(TVector3 posHitLayer1, TVector3
     double eta = posHitLayer1.Eta();
     if (abs(eta) > mEtaMax)
       return kFALSE;
+    if (mTables) {
+      double coord[3] = {deltaEta, deltaPhi, eta};
+      return mTableAcc3D->GetValue(coord);
+    }
     return mTrackletAcc3D->GetBinContent(mTrackletAcc3D->FindBin(deltaEta, deltaPhi, eta));
   }
 
+  else if (mTables) {
+    double coord[2] = {deltaEta, deltaPhi};
+    return mTableAcc2D->GetValue(coord);
+  }
+
   else
     return mTrackletAcc2D->GetBinContent(mTrackletAcc2D->FindBin(deltaEta, deltaPhi));
 
@@ -113,7 +172,7 @@ bool MIDTrackletSelector::IsMIDTrackletSelectedWithSearchSpot(TVector3 posHitLay
   double deltaPhiITS = posITStrackLayer1.DeltaPhi(posHitLayer1);
   double deltaEtaITS = posITStrackLayer1.Eta() - posHitLayer1.Eta();
 
-  if (TMath::Sqrt(deltaPhiITS * deltaPhiITS + deltaEtaITS * deltaEtaITS) > 0.2)
+  if (TMath::Sqrt(deltaPhiITS * deltaPhiITS + deltaEtaITS * deltaEtaITS) > mSearchSpotRadius)
     return kFALSE;
 
   return IsMIDTrackletSelected(posHitLayer1, posHitLayer2, evalEta);
@@ -150,6 +209,15 @@ bool MIDTrackletSelector::IsMIDTrackletSelected(TVector3 posHitLayer1, TVector3
 
   double coord[4] = {deltaEta, deltaPhi, eta, mom};
 
+  if (mTables) {
+    if (charge > 0)
+      return mTableAcc4D[kMuonPlus]->GetValue(coord);
+    else if (charge < 0)
+      return mTableAcc4D[kMuonMinus]->GetValue(coord);
+    else
+      return mTableAcc4D[kAllMuons]->GetValue(coord);
+  }
+
   if (charge > 0)
     return mTrackletAcc4D[kMuonPlus]->GetBinContent(mTrackletAcc4D[kMuonPlus]->GetBin(coord));
   else if (charge < 0)
@@ -179,7 +247,7 @@ bool MIDTrackletSelector::IsMIDTrackletSelectedWithSearchSpot(TVector3 posHitLay
   double deltaPhiITS = posITStrackLayer1.DeltaPhi(posHitLayer1);
   double deltaEtaITS = posITStrackLayer1.Eta() - posHitLayer1.Eta();
 
-  if (TMath::Sqrt(deltaPhiITS * deltaPhiITS + deltaEtaITS * deltaEtaITS) > 0.2)
+  if (TMath::Sqrt(deltaPhiITS * deltaPhiITS + deltaEtaITS * deltaEtaITS) > mSearchSpotRadius)
     return kFALSE;
 
   return IsMIDTrackletSelected(posHitLayer1, posHitLayer2, trackITS, charge);
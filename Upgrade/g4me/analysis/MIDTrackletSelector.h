@@ -8,6 +8,8 @@
 #include "TVector3.h"
 #include "TMath.h"
 
+#include "AccMapTables.h"
+
 using namespace std;
 
 class MIDTrackletSelector
@@ -23,6 +25,8 @@ class MIDTrackletSelector
          kNChargeOptions };
 
   bool Setup(const Char_t* nameInputFile);
+  bool SetupFromTables(const Char_t* nameInputFile);
+  bool IsUsingTables() { return mTables; }
   bool IsSelectorSetup() { return mIsSelectorSetup; }
   bool IsMIDTrackletSelected(TVector3 posHitLayer1, TVector3 posHitLayer2, bool evalEta);
   bool IsMIDTrackletSelected(TVector3 posHitLayer1, TVector3 posHitLayer2, TVector3 trackITS, int charge);
@@ -32,16 +36,25 @@ class MIDTrackletSelector
   TH2C* GetAcc2D() { return mTrackletAcc2D; }
   TH3C* GetAcc3D() { return mTrackletAcc3D; }
   THnSparse* GetAcc4D(int charge) { return mTrackletAcc4D[charge]; }
+  const AccMapTable* GetTableAcc2D() { return mTableAcc2D; }
+  const AccMapTable* GetTableAcc3D() { return mTableAcc3D; }
+  const AccMapTable* GetTableAcc4D(int charge) { return mTableAcc4D[charge]; }
+  double GetSearchSpotRadius() { return mSearchSpotRadius; }
 
  protected:
   TFile* mInputFile;
   TH3C* mTrackletAcc3D;
   TH2C* mTrackletAcc2D;
   THnSparse* mTrackletAcc4D[kNChargeOptions];
+  AccMapTables* mTables; // memory-mapped tables written by BuildAccMapTables.C, used instead of the histograms if set
+  const AccMapTable* mTableAcc2D;
+  const AccMapTable* mTableAcc3D;
+  const AccMapTable* mTableAcc4D[kNChargeOptions];
   bool mIsSelectorSetup;
   double mEtaMax;
   double mMomMax;
   double mMomMin;
+  double mSearchSpotRadius; // max. (eta, phi) distance between the ITS track at the 1st MID layer and the tracklet
 };
 
 #endif
@@ -0,0 +1,240 @@
+#include "TabulatedMaterialInterface.h"
+#include "TMath.h"
+#include <algorithm>
+#include <stdio.h>
+
+TabulatedMaterialInterface::TabulatedMaterialInterface(genfit::TGeoMaterialInterface* tgeoInterface) : mTGeoInterface(tgeoInterface)
+{
+
+  mUseTGeo = kFALSE;
+  mIsSetup = kFALSE;
+  mMaxStep = 20.;
+
+  // density (g/cm3), Z, A, radiation length (cm), mean excitation energy (eV)
+  // (for PbWO4, Z and A are averaged with the mass fractions of G4_PbWO4 (O: 0.1406, W: 0.4040, Pb: 0.4553), as in the TGeoMixture)
+  mMaterials[kPbWO4] = genfit::Material(8.28, 68.36, 170.88, 0.8903, 600.7);
+  mMaterials[kFe] = genfit::Material(7.874, 26., 55.845, 1.757, 286.0);
+  mVacuum = genfit::Material(1.e-25, 1., 1.00794, 1.e24, 19.2);
+
+  for (int i = 0; i < 3; i++) {
+    mPos[i] = 0;
+    mDir[i] = 0;
+  }
+  mCurrentMaterial = -1;
+}
+
+//==========================================================================================================
+
+bool TabulatedMaterialInterface::AddSegments(const Char_t* nameFile, double rMin, double halfLength, int material,
+                                             vector<double>& zMin, vector<double>& zMax, vector<Segment>& segments)
+{
+
+  FILE* file = fopen(nameFile, "r");
+  if (!file) {
+    printf("File %s not found\n", nameFile);
+    return kFALSE;
+  }
+
+  // EmCalThicknessVsZ.txt: z, thickness; AbsoThicknessVsZ.txt: z, thickness, half length (all in cm)
+  char line[256];
+  int nSegments = 0;
+  while (fgets(line, sizeof(line), file)) {
+    double z = 0, thickness = 0, halfLengthLine = halfLength;
+    int nRead = sscanf(line, "%lf %lf %lf", &z, &thickness, &halfLengthLine);
+    if (nRead < 2)
+      continue;
+    if (thickness <= 0)
+      continue;
+    zMin.push_back(z - halfLengthLine);
+    zMax.push_back(z + halfLengthLine);
+    segments.push_back({rMin, rMin + thickness, material});
+    nSegments++;
+  }
+  fclose(file);
+
+  if (!nSegments) {
+    printf("No segments found in file %s\n", nameFile);
+    return kFALSE;
+  }
+  return kTRUE;
+}
+
+//==========================================================================================================
+
+bool TabulatedMaterialInterface::Setup(const Char_t* nameEmCalFile, const Char_t* nameAbsoFile,
+                                       double emcalRmin, double absoRmin, double emcalHalfLength)
+{
+
+  vector<double> zMin, zMax;
+  vector<Segment> segments;
+
+  if (!AddSegments(nameEmCalFile, emcalRmin, emcalHalfLength, kPbWO4, zMin, zMax, segments))
+    return kFALSE;
+  if (!AddSegments(nameAbsoFile, absoRmin, 0, kFe, zMin, zMax, segments))
+    return kFALSE;
+
+  // z slices delimited by all the segment edges
+  mZEdges.clear();
+  mZEdges.insert(mZEdges.end(), zMin.begin(), zMin.end());
+  mZEdges.insert(mZEdges.end(), zMax.begin(), zMax.end());
+  sort(mZEdges.begin(), mZEdges.end());
+  mZEdges.erase(unique(mZEdges.begin(), mZEdges.end()), mZEdges.end());
+
+  mSlices.assign(mZEdges.size() - 1, vector<Segment>());
+  for (unsigned int iSlice = 0; iSlice < mSlices.size(); iSlice++) {
+    double zCenter = 0.5 * (mZEdges[iSlice] + mZEdges[iSlice + 1]);
+    for (unsigned int iSegment = 0; iSegment < segments.size(); iSegment++) {
+      if (zMin[iSegment] <= zCenter && zCenter < zMax[iSegment])
+        mSlices[iSlice].push_back(segments[iSegment]);
+    }
+    sort(mSlices[iSlice].begin(), mSlices[iSlice].end(), [](const Segment& a, const Segment& b) { return a.rMin < b.rMin; });
+  }
+
+  mIsSetup = kTRUE;
+
+  printf("Setup of TabulatedMaterialInterface successfully completed\n");
+  Print();
+  return kTRUE;
+}
+
+//==========================================================================================================
+
+void TabulatedMaterialInterface::Print(Option_t*) const
+{
+
+  printf("TabulatedMaterialInterface: %zu z slices between z = %.1f and %.1f cm, max. step %.1f cm\n",
+         mSlices.size(), mZEdges.empty() ? 0. : mZEdges.front(), mZEdges.empty() ? 0. : mZEdges.back(), mMaxStep);
+  const char* nameMaterial[kNMaterials] = {"PbWO4", "Fe"};
+  for (unsigned int iSlice = 0; iSlice < mSlices.size(); iSlice++) {
+    printf("  z = [%7.1f, %7.1f]:", mZEdges[iSlice], mZEdges[iSlice + 1]);
+    for (const auto& segment : mSlices[iSlice])
+      printf("  %s r = [%.1f, %.1f] (%.1f X0)", nameMaterial[segment.material], segment.rMin, segment.rMax,
+             (segment.rMax - segment.rMin) / mMaterials[segment.material].radiationLength);
+    printf("\n");
+  }
+}
+
+//==========================================================================================================
+
+int TabulatedMaterialInterface::FindSlice(double z) const
+{
+
+  if (mZEdges.size() < 2 || z < mZEdges.front() || z >= mZEdges.back())
+    return -1;
+  return int(upper_bound(mZEdges.begin(), mZEdges.end(), z) - mZEdges.begin()) - 1;
+}
+
+//==========================================================================================================
+
+int TabulatedMaterialInterface::FindMaterial(int iSlice, double r) const
+{
+
+  if (iSlice < 0)
+    return -1;
+  for (const auto& segment : mSlices[iSlice]) {
+    if (segment.rMin <= r && r < segment.rMax)
+      return segment.material;
+  }
+  return -1;
+}
+
+//==========================================================================================================
+
+double TabulatedMaterialInterface::DistanceToCylinder(double x, double y, double dirX, double dirY, double radius) const
+{
+
+  // smallest positive path length of the straight line (x, y) + s * (dirX, dirY) to the cylinder of given radius
+  double a = dirX * dirX + dirY * dirY;
+  if (a < 1.e-12)
+    return 1.e30;
+  double b = 2. * (x * dirX + y * dirY);
+  double c = x * x + y * y - radius * radius;
+  double disc = b * b - 4. * a * c;
+  if (disc < 0)
+    return 1.e30;
+  double sqrtDisc = TMath::Sqrt(disc);
+  double s1 = (-b - sqrtDisc) / (2. * a);
+  double s2 = (-b + sqrtDisc) / (2. * a);
+  if (s1 > 0)
+    return s1;
+  if (s2 > 0)
+    return s2;
+  return 1.e30;
+}
+
+//==========================================================================================================
+
+bool TabulatedMaterialInterface::initTrack(double posX, double posY, double posZ, double dirX, double dirY, double dirZ)
+{
+
+  if (mUseTGeo)
+    return mTGeoInterface->initTrack(posX, posY, posZ, dirX, dirY, dirZ);
+
+  mPos[0] = posX;
+  mPos[1] = posY;
+  mPos[2] = posZ;
+  mDir[0] = dirX;
+  mDir[1] = dirY;
+  mDir[2] = dirZ;
+
+  int material = FindMaterial(FindSlice(posZ), TMath::Sqrt(posX * posX + posY * posY));
+  bool changed = (material != mCurrentMaterial);
+  mCurrentMaterial = material;
+  return changed;
+}
+
+//==========================================================================================================
+
+genfit::Material TabulatedMaterialInterface::getMaterialParameters()
+{
+
+  if (mUseTGeo)
+    return mTGeoInterface->getMaterialParameters();
+
+  if (mCurrentMaterial < 0)
+    return mVacuum;
+  return mMaterials[mCurrentMaterial];
+}
+
+//==========================================================================================================
+
+double TabulatedMaterialInterface::findNextBoundary(const genfit::RKTrackRep* rep, const genfit::M1x7& state7, double sMax, bool varField)
+{
+
+  if (mUseTGeo)
+    return mTGeoInterface->findNextBoundary(rep, state7, sMax, varField);
+
+  const double overshoot = 1.e-3; // step slightly beyond the boundary, to be in the next cell at the next initTrack (in cm)
+
+  double sign = (sMax < 0) ? -1. : 1.;
+  double x = state7[0], y = state7[1], z = state7[2];
+  double dirX = sign * state7[3], dirY = sign * state7[4], dirZ = sign * state7[5];
+
+  double step = TMath::Min(TMath::Abs(sMax), mMaxStep);
+
+  // z boundaries
+  if (!mZEdges.empty() && TMath::Abs(dirZ) > 1.e-12) {
+    int iSlice = FindSlice(z);
+    double zNext = 0;
+    if (iSlice < 0)
+      zNext = (dirZ > 0) ? (z < mZEdges.front() ? mZEdges.front() : 1.e30) : (z >= mZEdges.back() ? mZEdges.back() : -1.e30);
+    else
+      zNext = (dirZ > 0) ? mZEdges[iSlice + 1] : mZEdges[iSlice];
+    if (TMath::Abs(zNext) < 1.e29)
+      step = TMath::Min(step, (zNext - z) / dirZ + overshoot);
+  }
+
+  // radial boundaries of the segments in the current slice
+  int iSlice = FindSlice(z);
+  if (iSlice >= 0) {
+    for (const auto& segment : mSlices[iSlice]) {
+      step = TMath::Min(step, DistanceToCylinder(x, y, dirX, dirY, segment.rMin) + overshoot);
+      step = TMath::Min(step, DistanceToCylinder(x, y, dirX, dirY, segment.rMax) + overshoot);
+    }
+  }
+
+  step = TMath::Min(TMath::Max(step, overshoot), TMath::Abs(sMax));
+  return sign * step;
+}
+
+//==========================================================================================================
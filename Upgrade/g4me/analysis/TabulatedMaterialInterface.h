@@ -0,0 +1,74 @@
+#ifndef TabulatedMaterialInterface_h
+#define TabulatedMaterialInterface_h
+
+#include <AbsMaterialInterface.h>
+#include <Material.h>
+#include <RKTrackRep.h>
+#include <TGeoMaterialInterface.h>
+
+#include "TMath.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// GenFit material interface describing the EMCal and the absorber as (z, r) tables of cylindrical segments,
+// built from the thickness maps produced by GetEmCalThicknessVsZ.C and GetAbsoThicknessVsZ.C.
+// The rest of the volume (including the ITS layers and the beam pipe) is treated as vacuum.
+// The boundaries are found along straight lines, with steps limited to mMaxStep, instead of navigating the TGeo geometry.
+// If a TGeo interface is provided, the fits can be switched back to it (e.g. to validate the tables) with SetUseTGeo.
+// The TGeo interface is owned by this class.
+
+class TabulatedMaterialInterface : public genfit::AbsMaterialInterface
+{
+
+ public:
+  TabulatedMaterialInterface(genfit::TGeoMaterialInterface* tgeoInterface = 0);
+  ~TabulatedMaterialInterface() = default;
+
+  enum { kPbWO4,
+         kFe,
+         kNMaterials };
+
+  bool Setup(const Char_t* nameEmCalFile = "EmCalThicknessVsZ.txt",
+             const Char_t* nameAbsoFile = "AbsoThicknessVsZ.txt",
+             double emcalRmin = 130,
+             double absoRmin = 162,
+             double emcalHalfLength = 5);
+  bool IsSetup() { return mIsSetup; }
+  void SetUseTGeo(bool useTGeo) { mUseTGeo = (useTGeo && mTGeoInterface); }
+  bool IsUsingTGeo() { return mUseTGeo; }
+  void SetMaxStep(double maxStep) { mMaxStep = maxStep; }
+  void Print(Option_t* option = "") const override;
+
+  // genfit::AbsMaterialInterface
+  bool initTrack(double posX, double posY, double posZ, double dirX, double dirY, double dirZ) override;
+  genfit::Material getMaterialParameters() override;
+  double findNextBoundary(const genfit::RKTrackRep* rep, const genfit::M1x7& state7, double sMax, bool varField = true) override;
+
+ protected:
+  struct Segment {
+    double rMin;
+    double rMax;
+    int material;
+  };
+
+  bool AddSegments(const Char_t* nameFile, double rMin, double halfLength, int material, vector<double>& zMin, vector<double>& zMax, vector<Segment>& segments);
+  int FindSlice(double z) const;
+  int FindMaterial(int iSlice, double r) const;
+  double DistanceToCylinder(double x, double y, double dirX, double dirY, double radius) const;
+
+  std::unique_ptr<genfit::TGeoMaterialInterface> mTGeoInterface;
+  bool mUseTGeo;
+  bool mIsSetup;
+  double mMaxStep;                 // max. straight-line step (in cm)
+  vector<double> mZEdges;          // edges of the z slices
+  vector<vector<Segment>> mSlices; // radial segments of material in each z slice, ordered in r
+  genfit::Material mMaterials[kNMaterials];
+  genfit::Material mVacuum;
+  double mPos[3];
+  double mDir[3];
+  int mCurrentMaterial;
+};
+
+#endif
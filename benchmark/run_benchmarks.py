@@ -0,0 +1,415 @@
+#!/usr/bin/env python3
+
+"""
+Runs the benchmarks of the analysis code on synthetic inputs and compares the results with a baseline.
+
+Steps (each in a separate ROOT process, timed with its peak resident memory):
+- generate: synthetic inputs (GenerateBenchmarkInputs.C)
+- build_acc_tables: acceptance-map tables (Upgrade/g4me/analysis/BuildAccMapTables.C)
+- micro_g4me: micro benchmarks of IO_t, MIDTrackletSelector and the tracklet pairing (BenchmarkG4me.C)
+- micro_template_fit: micro benchmark of the template fit (BenchmarkTemplateFit.C)
+- prepare_tracks: Upgrade/g4me/analysis/PrepareTracksForMatchingAndFit.C
+- template_fit, template_fit_draw: FirstAnalysis/Correlations/doTemplate.C without and with drawing
+- make_plots: codeHF/Compare.C (MakePlots) with the "events tracks skim" lists
+
+Everything runs offline. Only ROOT is needed.
+The results are written in a JSON file which can be used as a baseline for later runs.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import shutil
+import subprocess as sp  # nosec B404
+import sys
+import time
+
+dir_bench = os.path.dirname(os.path.realpath(__file__))
+dir_repo = os.path.dirname(dir_bench)
+dir_g4me = os.path.join(dir_repo, "Upgrade", "g4me", "analysis")
+
+# names of the steps in the order of execution
+steps_all = [
+    "generate",
+    "build_acc_tables",
+    "micro_g4me",
+    "micro_template_fit",
+    "prepare_tracks",
+    "template_fit",
+    "template_fit_draw",
+    "make_plots",
+]
+# steps whose results are only the micro benchmarks they write
+steps_micro = ["micro_g4me", "micro_template_fit"]
+name_file_micro = "results_micro.jsonl"
+
+
+def eprint(*args, **kwargs):
+    """Print to stderr."""
+    print(*args, file=sys.stderr, **kwargs)
+
+
+def msg_err(message: str):
+    """Print an error message."""
+    eprint("\x1b[1;31mError: %s\x1b[0m" % message)
+
+
+def msg_fatal(message: str):
+    """Print an error message and exit."""
+    msg_err(message)
+    sys.exit(1)
+
+
+def msg_warn(message: str):
+    """Print a warning message."""
+    eprint("\x1b[1;36mWarning:\x1b[0m %s" % message)
+
+
+def msg_bold(message: str):
+    """Print a boldface message."""
+    eprint("\x1b[1m%s\x1b[0m" % message)
+
+
+def quote(arg) -> str:
+    """Format a macro argument."""
+    if isinstance(arg, bool):
+        return "true" if arg else "false"
+    if isinstance(arg, str):
+        return '"%s"' % arg
+    return str(arg)
+
+
+def macro_call(path: str, args: list, compile_macro=True) -> str:
+    """Return the ROOT command-line argument executing a macro."""
+    return "%s%s(%s)" % (path, "+" if compile_macro else "", ", ".join(quote(a) for a in args))
+
+
+def get_root_executable() -> str:
+    """Return the ROOT executable. root.exe is preferred to get the resource usage of the ROOT process itself."""
+    for name in ("root.exe", "root"):
+        path = shutil.which(name)
+        if path:
+            return path
+    msg_fatal("ROOT not found")
+    return ""
+
+
+def run_root(name: str, cmd_root: list, dir_work: str, dir_build: str, preload: list) -> dict:
+    """Run ROOT with the given command-line arguments and return the wall time, CPU time and peak memory."""
+    cmd = [get_root_executable(), "-b", "-q", "-l", "-e", 'gSystem->SetBuildDir("%s")' % dir_build]
+    for path in preload:
+        cmd += ["-e", 'if (!gSystem->CompileMacro("%s", "k")) gSystem->Exit(1)' % path]
+    cmd += cmd_root
+    path_log = os.path.join(dir_work, "%s.log" % name)
+    with open(path_log, "w") as file_log:
+        file_log.write(" ".join(cmd) + "\n")
+        file_log.flush()
+        time_start = time.perf_counter()
+        proc = sp.Popen(cmd, cwd=dir_work, stdout=file_log, stderr=sp.STDOUT)  # nosec B603
+        # wait4 gives the resource usage of this process only (unlike getrusage(RUSAGE_CHILDREN))
+        _, status, usage = os.wait4(proc.pid, 0)
+        time_real = time.perf_counter() - time_start
+    proc.returncode = os.waitstatus_to_exitcode(status)  # already reaped
+    result = {
+        "kind": "e2e",
+        "real_s": round(time_real, 6),
+        "cpu_s": round(usage.ru_utime + usage.ru_stime, 6),
+        "max_rss_kb": usage.ru_maxrss,
+        "status": "ok",
+    }
+    if proc.returncode != 0:
+        msg_err("Step %s failed with exit code %d. See %s" % (name, proc.returncode, path_log))
+        result["status"] = "failed"
+    else:
+        eprint(
+            "%-20s real: %9.3f s, cpu: %9.3f s, max. RSS: %9d kB" % (name, time_real, result["cpu_s"], usage.ru_maxrss)
+        )
+    return result
+
+
+def get_step_command(step: str, args, dir_work: str) -> tuple:
+    """Return the ROOT command-line arguments and the macros to be compiled and loaded first for a step."""
+    path_tables = os.path.join(dir_g4me, "AccMapTables.cxx")
+    path_selector = os.path.join(dir_g4me, "MIDTrackletSelector.cxx")
+    if step == "generate":
+        macro = os.path.join(dir_bench, "GenerateBenchmarkInputs.C")
+        return [macro_call(macro, [dir_work, args.events, args.tracks, args.noise_hits, args.entries, args.seed])], []
+    if step == "build_acc_tables":
+        macro = os.path.join(dir_g4me, "BuildAccMapTables.C")
+        macro_args = ["histosTracking.root", "muonTrackletAcceptance.root", "muonAcceptance.accmap", 1.5, args.threads]
+        return [macro_call(macro, macro_args)], [path_tables]
+    if step == "micro_g4me":
+        macro = os.path.join(dir_bench, "BenchmarkG4me.C")
+        macro_args = [
+            "g4me.root",
+            "muonTrackletAcceptance.root",
+            "muonAcceptance.accmap",
+            name_file_micro,
+            args.lookups,
+        ]
+        return [macro_call(macro, macro_args)], [path_tables, path_selector]
+    if step == "micro_template_fit":
+        macro = os.path.join(dir_bench, "BenchmarkTemplateFit.C")
+        return [macro_call(macro, ["phi_proj.root", name_file_micro, args.fits], False)], []
+    if step == "prepare_tracks":
+        macro = os.path.join(dir_g4me, "PrepareTracksForMatchingAndFit.C")
+        cmd = [
+            "-e",
+            'gSystem->AddIncludePath("-I%s")' % args.style,
+            "-e",
+            'gInterpreter->AddIncludePath("%s")' % args.style,
+        ]
+        return cmd + [macro_call(macro, ["g4me.root", "tracksForFit.root"])], [path_tables, path_selector]
+    if step in ("template_fit", "template_fit_draw"):
+        macro = os.path.join(dir_repo, "FirstAnalysis", "Correlations", "doTemplate.C")
+        draw = step == "template_fit_draw"
+        return [macro_call(macro, ["phi_proj.root", "templateResult.root", "plots", False, draw, draw], False)], []
+    if step == "make_plots":
+        macro = os.path.join(dir_repo, "codeHF", "Compare.C")
+        macro_args = ["AnalysisResults_O2.root", "AnalysisResults_ALI.root", " events tracks skim ", True]
+        return [macro_call(macro, macro_args, False)], []
+    msg_fatal("Unknown step %s" % step)
+    return [], []
+
+
+def read_micro_results(path_file: str) -> dict:
+    """Read the results of the micro benchmarks."""
+    results = {}
+    if not os.path.isfile(path_file):
+        return results
+    with open(path_file, "r") as file_micro:
+        for line in file_micro:
+            line = line.strip()
+            if not line:
+                continue
+            result = json.loads(line)
+            name = result.pop("name")
+            result["status"] = "ok"
+            results[name] = result
+    return results
+
+
+def merge_result(results: dict, name: str, result: dict):
+    """Merge the result of a repetition: minimum times, maximum memory, failure if any failed."""
+    if name not in results:
+        results[name] = result
+        return
+    merged = results[name]
+    for key in ("real_s", "cpu_s", "per_call_us"):
+        if key in result:
+            merged[key] = min(merged[key], result[key])
+    merged["max_rss_kb"] = max(merged["max_rss_kb"], result["max_rss_kb"])
+    if result["status"] != "ok":
+        merged["status"] = result["status"]
+
+
+def get_metadata(args) -> dict:
+    """Collect information about the machine, the software and the parameters."""
+    metadata = {
+        "date": datetime.datetime.now().isoformat(timespec="seconds"),
+        "host": platform.node(),
+        "platform": platform.platform(),
+        "cpu_count": os.cpu_count(),
+        "python": platform.python_version(),
+    }
+    for key, cmd in (("root", ["root-config", "--version"]), ("commit", ["git", "-C", dir_repo, "rev-parse", "HEAD"])):
+        try:
+            metadata[key] = sp.check_output(cmd, text=True, stderr=sp.DEVNULL).strip()  # nosec B603
+        except (OSError, sp.CalledProcessError):
+            metadata[key] = "unknown"
+    metadata["parameters"] = {
+        "events": args.events,
+        "tracks": args.tracks,
+        "noise_hits": args.noise_hits,
+        "entries": args.entries,
+        "lookups": args.lookups,
+        "fits": args.fits,
+        "threads": args.threads,
+        "seed": args.seed,
+        "repeat": args.repeat,
+    }
+    return metadata
+
+
+def get_metric(result: dict) -> tuple:
+    """Return the name and the value of the timing metric of a result."""
+    if result.get("kind") == "micro":
+        return "per_call_us", result.get("per_call_us")
+    return "real_s", result.get("real_s")
+
+
+def compare_with_baseline(results: dict, path_baseline: str, tol_time: float, tol_memory: float) -> int:
+    """Compare the results with a baseline. Return the number of regressions."""
+    try:
+        with open(path_baseline, "r") as file_baseline:
+            baseline = json.load(file_baseline)
+    except (IOError, ValueError):
+        msg_fatal("Failed to load the baseline %s" % path_baseline)
+    par_base = baseline.get("metadata", {}).get("parameters", {})
+    par_new = results["metadata"]["parameters"]
+    for key in par_new:
+        if key != "repeat" and par_base.get(key) != par_new[key]:
+            msg_warn("Parameter %s differs from the baseline: %s vs %s" % (key, par_new[key], par_base.get(key)))
+    res_base = baseline.get("results", {})
+    res_new = results["results"]
+    n_regressions = 0
+    msg_bold(
+        "\nComparison with the baseline %s (tolerance: time %g%%, memory %g%%)"
+        % (path_baseline, 100 * tol_time, 100 * tol_memory)
+    )
+    eprint(
+        "%-32s %-12s %12s %12s %7s %12s %12s %7s  %s"
+        % ("name", "metric", "baseline", "current", "ratio", "RSS base", "RSS current", "ratio", "verdict")
+    )
+    for name in list(res_new) + [n for n in res_base if n not in res_new]:
+        if name not in res_new:
+            eprint("%-32s missing in the current results" % name)
+            continue
+        if name not in res_base:
+            eprint("%-32s new" % name)
+            continue
+        new, base = res_new[name], res_base[name]
+        if new["status"] != "ok":
+            verdict = "FAILED"
+            n_regressions += 1
+            eprint("%-32s %s" % (name, verdict))
+            continue
+        metric, value_new = get_metric(new)
+        _, value_base = get_metric(base)
+        ratio_time = value_new / value_base if value_base else 1.0
+        ratio_mem = new["max_rss_kb"] / base["max_rss_kb"] if base.get("max_rss_kb", 0) > 0 else 1.0
+        verdicts = []
+        if ratio_time > 1 + tol_time:
+            verdicts.append("SLOWER")
+        elif ratio_time < 1 - tol_time:
+            verdicts.append("faster")
+        if ratio_mem > 1 + tol_memory:
+            verdicts.append("MORE MEMORY")
+        elif ratio_mem < 1 - tol_memory:
+            verdicts.append("less memory")
+        if "SLOWER" in verdicts or "MORE MEMORY" in verdicts:
+            n_regressions += 1
+        eprint(
+            "%-32s %-12s %12.4f %12.4f %7.3f %12d %12d %7.3f  %s"
+            % (
+                name,
+                metric,
+                value_base,
+                value_new,
+                ratio_time,
+                base["max_rss_kb"],
+                new["max_rss_kb"],
+                ratio_mem,
+                ", ".join(verdicts) or "ok",
+            )
+        )
+    return n_regressions
+
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(
+        description="Runs the benchmarks on synthetic inputs and compares the results with a baseline."
+    )
+    parser.add_argument(
+        "-w", "--workdir", default="benchmark_work", help="working directory for inputs, outputs and logs"
+    )
+    parser.add_argument("-o", "--output", default="benchmark_results.json", help="output JSON file with the results")
+    parser.add_argument("-b", "--baseline", help="JSON file with baseline results to compare with")
+    parser.add_argument(
+        "-r", "--repeat", type=int, default=3, help="number of repetitions of each step (minimum time is kept)"
+    )
+    parser.add_argument("-s", "--steps", nargs="+", choices=steps_all, default=steps_all, help="steps to run")
+    parser.add_argument("--events", type=int, default=10, help="number of generated events")
+    parser.add_argument("--tracks", type=int, default=500, help="number of primary tracks per event (occupancy)")
+    parser.add_argument("--noise-hits", type=int, default=0, help="number of uncorrelated hits per MID layer per event")
+    parser.add_argument("--entries", type=int, default=100000, help="number of entries of the generated histograms")
+    parser.add_argument(
+        "--lookups", type=int, default=1000000, help="number of selector lookups in the micro benchmarks"
+    )
+    parser.add_argument(
+        "--fits", type=int, default=5, help="number of repetitions of all template fits in the micro benchmark"
+    )
+    parser.add_argument(
+        "--threads", type=int, default=0, help="number of threads for the acceptance-map fits (0: all cores)"
+    )
+    parser.add_argument("--seed", type=int, default=1, help="random seed of the generation")
+    parser.add_argument("--style", help="directory with the g4me style.C (a dummy is used if not provided)")
+    parser.add_argument("--tolerance", type=float, default=0.1, help="relative tolerance on the time")
+    parser.add_argument("--tolerance-memory", type=float, default=0.1, help="relative tolerance on the peak memory")
+    parser.add_argument("--no-fail", action="store_true", help="do not exit with an error code in case of regressions")
+    args = parser.parse_args()
+
+    if args.repeat < 1:
+        msg_fatal("Number of repetitions must be positive.")
+    if args.baseline and not os.path.isfile(args.baseline):
+        msg_fatal("Baseline %s does not exist." % args.baseline)
+
+    dir_work = os.path.realpath(args.workdir)
+    dir_build = os.path.join(dir_work, "build")
+    os.makedirs(dir_build, exist_ok=True)
+    os.makedirs(os.path.join(dir_work, "plots"), exist_ok=True)
+    if not args.style:
+        # PrepareTracksForMatchingAndFit.C includes the style.C of g4me, which only sets the plotting style.
+        args.style = dir_work
+        with open(os.path.join(dir_work, "style.C"), "w") as file_style:
+            file_style.write("void style() {}\n")
+    args.style = os.path.realpath(args.style)
+
+    # compile all the compiled macros first so that the compilation is not timed
+    msg_bold("Compiling")
+    macros_compiled = [
+        os.path.join(dir_g4me, "AccMapTables.cxx"),
+        os.path.join(dir_g4me, "MIDTrackletSelector.cxx"),
+        os.path.join(dir_bench, "GenerateBenchmarkInputs.C"),
+        os.path.join(dir_g4me, "BuildAccMapTables.C"),
+        os.path.join(dir_bench, "BenchmarkG4me.C"),
+    ]
+    cmd_compile = []
+    if "prepare_tracks" in args.steps:
+        macros_compiled.append(os.path.join(dir_g4me, "PrepareTracksForMatchingAndFit.C"))
+        cmd_compile = ["-e", 'gSystem->AddIncludePath("-I%s")' % args.style]
+    if run_root("compile", cmd_compile, dir_work, dir_build, macros_compiled)["status"] != "ok":
+        msg_fatal("Compilation failed.")
+
+    results = {"metadata": get_metadata(args), "results": {}}
+    path_micro = os.path.join(dir_work, name_file_micro)
+    for step in [s for s in steps_all if s in args.steps]:
+        cmd_root, preload = get_step_command(step, args, dir_work)
+        # the inputs are generated only once
+        n_rep = 1 if step == "generate" else args.repeat
+        msg_bold("Running %s (%d times)" % (step, n_rep))
+        for _ in range(n_rep):
+            if step in steps_micro and os.path.isfile(path_micro):
+                os.remove(path_micro)
+            result = run_root(step, cmd_root, dir_work, dir_build, preload)
+            if step in steps_micro:
+                if result["status"] != "ok":
+                    merge_result(results["results"], step, result)
+                for name, result_micro in read_micro_results(path_micro).items():
+                    merge_result(results["results"], name, result_micro)
+            else:
+                merge_result(results["results"], step, result)
+        if step == "generate" and result["status"] != "ok":
+            msg_fatal("Generation of the inputs failed.")
+
+    with open(args.output, "w") as file_out:
+        json.dump(results, file_out, indent=2)
+    msg_bold("Results written in %s" % args.output)
+
+    n_failed = sum(1 for r in results["results"].values() if r["status"] != "ok")
+    n_regressions = 0
+    if args.baseline:
+        n_regressions = compare_with_baseline(results, args.baseline, args.tolerance, args.tolerance_memory)
+        if n_regressions:
+            msg_warn("%d regression(s) with respect to the baseline" % n_regressions)
+    if n_failed:
+        msg_err("%d step(s) failed" % n_failed)
+    if (n_failed or n_regressions) and not args.no_fail:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
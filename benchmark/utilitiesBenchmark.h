@@ -0,0 +1,63 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// Benchmark utilities
+
+#ifndef BENCHMARK_UTILITIESBENCHMARK_H_
+#define BENCHMARK_UTILITIESBENCHMARK_H_
+
+#include <cstdio>  // FILE, fopen, fprintf
+#include <cstring> // strncmp
+
+#include <TStopwatch.h>
+#include <TString.h>
+
+// Get the peak resident memory of the current process (in kB) from /proc/self/status (VmHWM).
+// Returns -1 if not available.
+long GetMemoryHighWaterMark()
+{
+  FILE* file = fopen("/proc/self/status", "r");
+  if (!file) {
+    return -1;
+  }
+  char line[256];
+  long value = -1;
+  while (fgets(line, sizeof(line), file)) {
+    if (!strncmp(line, "VmHWM:", 6)) {
+      sscanf(line + 6, "%ld", &value);
+      break;
+    }
+  }
+  fclose(file);
+  return value;
+}
+
+// Append the result of a micro benchmark as a JSON line to the result file.
+// The stopwatch must be stopped. nCalls is the number of timed calls of the benchmarked operation.
+void WriteBenchmarkResult(TString pathFileResults, TString name, Long64_t nCalls, TStopwatch& stopwatch)
+{
+  Double_t timeReal = stopwatch.RealTime();
+  Double_t timeCpu = stopwatch.CpuTime();
+  Double_t timePerCall = nCalls > 0 ? 1.e6 * timeReal / nCalls : 0.;
+  long memory = GetMemoryHighWaterMark();
+  Printf("Benchmark %-30s calls: %10lld, real: %9.4f s, cpu: %9.4f s, per call: %10.4f us, VmHWM: %ld kB",
+         name.Data(), nCalls, timeReal, timeCpu, timePerCall, memory);
+  FILE* file = fopen(pathFileResults.Data(), "a");
+  if (!file) {
+    Error("WriteBenchmarkResult", "Failed to open file %s", pathFileResults.Data());
+    return;
+  }
+  fprintf(file, "{\"name\": \"%s\", \"kind\": \"micro\", \"calls\": %lld, \"real_s\": %.6f, \"cpu_s\": %.6f, \"per_call_us\": %.6f, \"max_rss_kb\": %ld}\n",
+          name.Data(), nCalls, timeReal, timeCpu, timePerCall, memory);
+  fclose(file);
+}
+
+#endif // BENCHMARK_UTILITIESBENCHMARK_H_
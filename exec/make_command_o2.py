@@ -6,12 +6,16 @@ Author: Vít Kučera <vit.kucera@cern.ch>
 """
 
 import argparse
+import json
 import os
 import sys
-from typing import List
+from typing import List, Tuple
 
 import yaml  # pylint: disable=import-error
 
+# PWG prefixes of executables which are not part of the device names
+pwg_prefixes = ("cf-", "dq-", "em-", "je-", "lf-", "ud-")
+
 
 def eprint(*args, **kwargs):
     """Print to stderr."""
@@ -150,30 +154,11 @@ def activate_workflow(wf: str, dic_wf: dict, mc=False, level=0, debug=False):
         dic_wf[wf] = {"activate": True}
 
 
-def main():
-    """Main function"""
-    parser = argparse.ArgumentParser(
-        description="Generates full O2 command based on a YAML " "database of workflows and options."
-    )
-    parser.add_argument("database", help="database with workflows and options")
-    parser.add_argument("-w", "--workflows", type=str, help="explicitly requested workflows")
-    parser.add_argument("--mc", action="store_true", help="Monte Carlo mode")
-    parser.add_argument("-t", "--tables", action="store_true", help="save table into trees")
-    parser.add_argument("-g", "--graph", action="store_true", help="make topology graph")
-    parser.add_argument("-d", "--debug", action="store_true", help="print debugging info")
-    parser.add_argument("-p", "--perf", action="store_true", help="produce performance profiling stats")
-    args = parser.parse_args()
-    path_file_database = args.database
-    debug = args.debug
-    workflows_add = args.workflows.split() if args.workflows else ""
-    mc_mode = args.mc
-    save_tables = args.tables
-    make_graph = args.graph
-    perf = args.perf
-
-    # Open database input file.
+def load_database(path_file_database: str, debug=False) -> dict:
+    """Load and check a workflow database."""
     if debug:
         eprint("Input database: " + path_file_database)
+    dic_in = None
     try:
         with open(path_file_database, "r") as file_database:
             dic_in = yaml.safe_load(file_database)
@@ -182,30 +167,12 @@ def main():
 
     # Check valid structure of the input database.
     if not healthy_structure(dic_in):
-        msg_fatal("Bad structure!")
+        msg_fatal("Bad structure of %s!" % path_file_database)
+    return dic_in
 
-    if mc_mode:
-        msg_warn("MC mode is on.")
-    if save_tables:
-        msg_warn("Tables will be saved in trees.")
-    if perf:
-        msg_warn(
-            "Performance profiling stats will be saved in perf.data files.\n"
-            "  Convert them with: perf script --demangle -i perf.data --no-inline |"
-            " c++filt -r -t  > profile.linux-perf.txt\n"
-            "  and upload the output to https://www.speedscope.app/."
-        )
-
-    # Get workflow-independent options.
-    dic_opt = dic_in["options"]
-    # options that appear only once
-    opt_global = join_strings(dic_opt["global"])
-    # options that appear for each workflow
-    opt_local = join_strings(dic_opt["local"])
-
-    # Get the workflow database.
-    dic_wf = dic_in["workflows"]
 
+def activate_workflows(dic_wf: dict, workflows_add: list, mc=False, debug=False):
+    """Activate primary workflows (from the database and the command line) and their dependencies."""
     # Get list of primary workflows to run.
     # already activated in the database
     list_wf_activated = [wf for wf in dic_wf if "activate" in dic_wf[wf] and dic_wf[wf]["activate"]]
@@ -228,29 +195,349 @@ def main():
     if debug:
         eprint("\nActivating workflows")
     for wf in list_wf_activated:
-        activate_workflow(wf, dic_wf, mc_mode, 0, debug)
+        activate_workflow(wf, dic_wf, mc, 0, debug)
 
-    # Get the list of tables and add the option to the local options.
-    if save_tables:
-        tables = []  # list of all tables of activated workflows
+
+def is_activated(dic_wf_single: dict) -> bool:
+    """Tell whether a workflow is activated."""
+    return "activate" in dic_wf_single and dic_wf_single["activate"]
+
+
+def get_tables(dic_wf: dict, mc=False) -> list:
+    """Get the list of tables of activated workflows."""
+    tables: List[str] = []
+    for wf, dic_wf_single in dic_wf.items():
+        if not is_activated(dic_wf_single):
+            continue
+        if "tables" not in dic_wf_single:
+            continue
+        tab_wf = dic_wf_single["tables"]
+        if isinstance(tab_wf, (str, list)):
+            join_to_list(tab_wf, tables)
+        elif isinstance(tab_wf, dict):
+            if "default" in tab_wf:
+                join_to_list(tab_wf["default"], tables)
+            if not mc and "real" in tab_wf:
+                join_to_list(tab_wf["real"], tables)
+            if mc and "mc" in tab_wf:
+                join_to_list(tab_wf["mc"], tables)
+        else:
+            msg_fatal('"tables" in %s must be str, list or dict, is %s' % (wf, type(tab_wf)))
+    return tables
+
+
+def get_executable(wf: str, dic_wf_single: dict) -> str:
+    """Get the executable of a workflow."""
+    if "executable" not in dic_wf_single:
+        return wf
+    exec_wf = dic_wf_single["executable"]
+    if not isinstance(exec_wf, str):
+        msg_fatal('"executable" in %s must be str, is %s' % (wf, type(exec_wf)))
+    return exec_wf
+
+
+def get_workflow_options(wf: str, dic_wf_single: dict, mc=False) -> str:
+    """Get the command line options of a workflow."""
+    if "options" not in dic_wf_single:
+        return ""
+    opt_wf = dic_wf_single["options"]
+    list_opt: List[str] = []
+    if isinstance(opt_wf, (str, list)):
+        list_opt.append(join_strings(opt_wf))
+    elif isinstance(opt_wf, dict):
+        if "default" in opt_wf:
+            list_opt.append(join_strings(opt_wf["default"]))
+        if not mc and "real" in opt_wf:
+            list_opt.append(join_strings(opt_wf["real"]))
+        if mc and "mc" in opt_wf:
+            list_opt.append(join_strings(opt_wf["mc"]))
+    else:
+        msg_fatal('"options" in %s must be str, list or dict, is %s' % (wf, type(opt_wf)))
+    return " ".join(list_opt)
+
+
+def get_device_base_names(exec_wf: str) -> list:
+    """Get the possible beginnings of the device names of an executable."""
+    base = exec_wf.replace("o2-analysis-", "", 1).lower()
+    names = [base]
+    # Device names usually do not contain the PWG prefix of the executable.
+    for prefix in pwg_prefixes:
+        if base.startswith(prefix):
+            names.append(base[len(prefix) :])
+    return names
+
+
+def match_device(device: str, base: str) -> bool:
+    """Tell whether a device name matches a base name derived from an executable."""
+    device = device.lower()
+    return device == base or device.startswith(base + "-") or device.replace("-", "") == base.replace("-", "")
+
+
+def get_activated_devices(dic_wf: dict, devices: list, label: str) -> Tuple[list, list]:
+    """Get the devices of activated workflows and the devices not attributed to any workflow
+    among the devices of a JSON configuration.
+    Devices are attributed to workflows by the "devices" key of the workflow or by the name of the executable.
+    A device matching several executables belongs to the one with the longest matching name."""
+    dic_dev: dict = {}  # {device: activated}
+    for dic_wf_single in dic_wf.values():
+        if "devices" in dic_wf_single:
+            list_dev: List[str] = []
+            join_to_list(dic_wf_single["devices"], list_dev)
+            for dev in list_dev:
+                dic_dev[dev] = dic_dev.get(dev, False) or is_activated(dic_wf_single)
+    devices_unknown: List[str] = []
+    for dev in devices:
+        if dev in dic_dev or dev.startswith("internal-"):
+            continue
+        length_best, activated = 0, False
         for wf, dic_wf_single in dic_wf.items():
-            if "activate" not in dic_wf_single or not dic_wf_single["activate"]:
+            if "devices" in dic_wf_single:
                 continue
-            if "tables" not in dic_wf_single:
+            for base in get_device_base_names(get_executable(wf, dic_wf_single)):
+                if not match_device(dev, base) or len(base) < length_best:
+                    continue
+                if len(base) > length_best:
+                    length_best, activated = len(base), False
+                activated = activated or is_activated(dic_wf_single)
+        if length_best:
+            dic_dev[dev] = activated
+        else:
+            devices_unknown.append(dev)
+    if devices_unknown:
+        msg_warn(
+            "%s: Devices not attributed to any workflow are merged but not routed "
+            '(add them in "devices" of their workflows): %s' % (label, ", ".join(devices_unknown))
+        )
+    return [dev for dev in devices if dic_dev.get(dev, False)], devices_unknown
+
+
+def split_options(string: str) -> dict:
+    """Split a string of command line options into a dictionary {option: full option string}."""
+    dic_opt: dict = {}
+    key = ""
+    for word in string.split():
+        if word.startswith("-") and not word.lstrip("-").replace(".", "").isdigit():
+            key = word
+            dic_opt[key] = word
+        elif key:
+            dic_opt[key] += " " + word
+        else:
+            dic_opt[word] = word
+    return dic_opt
+
+
+def merge_options(dic_merged: dict, string: str, label: str, conflicts: list):
+    """Merge command line options into a dictionary and record conflicting values."""
+    for key, value in split_options(string).items():
+        if key in dic_merged and dic_merged[key].replace('"', "") != value.replace('"', ""):
+            conflicts.append('Option %s: "%s" vs "%s" (%s)' % (key, dic_merged[key], value, label))
+            continue
+        dic_merged[key] = value
+
+
+def normalise_value(value):
+    """Unify equivalent representations of boolean configurables."""
+    if isinstance(value, str):
+        if value.lower() in ("true", "1"):
+            return "true"
+        if value.lower() in ("false", "0"):
+            return "false"
+    return value
+
+
+def merge_configurables(dic_merged: dict, dic_add: dict, path: str, label: str, conflicts: list):
+    """Merge device configurables recursively and record conflicting values."""
+    for key, value in dic_add.items():
+        path_key = "%s/%s" % (path, key)
+        if key not in dic_merged:
+            dic_merged[key] = value
+        elif isinstance(dic_merged[key], dict) and isinstance(value, dict):
+            merge_configurables(dic_merged[key], value, path_key, label, conflicts)
+        elif normalise_value(dic_merged[key]) != normalise_value(value):
+            conflicts.append('Configurable %s: "%s" vs "%s" (%s)' % (path_key, dic_merged[key], value, label))
+
+
+def get_train_name(path_file_database: str, names: list) -> str:
+    """Make a unique name of a train participant from the path of its database."""
+    name = os.path.basename(os.path.dirname(os.path.abspath(path_file_database)))
+    if not name or name in names:
+        name = os.path.splitext(os.path.basename(path_file_database))[0]
+    name_base, i = name, 1
+    while name in names:
+        name = "%s_%d" % (name_base, i)
+        i += 1
+    return name
+
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(
+        description="Generates full O2 command based on a YAML " "database of workflows and options."
+    )
+    parser.add_argument(
+        "database", nargs="+", help="database with workflows and options (several databases make a train)"
+    )
+    parser.add_argument(
+        "-w",
+        "--workflows",
+        type=str,
+        action="append",
+        help="explicitly requested workflows (train mode: once per database, in the same order)",
+    )
+    parser.add_argument("--mc", action="store_true", help="Monte Carlo mode")
+    parser.add_argument("-t", "--tables", action="store_true", help="save table into trees")
+    parser.add_argument("-g", "--graph", action="store_true", help="make topology graph")
+    parser.add_argument("-d", "--debug", action="store_true", help="print debugging info")
+    parser.add_argument("-p", "--perf", action="store_true", help="produce performance profiling stats")
+    parser.add_argument(
+        "-j", "--json", type=str, action="append", help="train mode: JSON configuration, once per database"
+    )
+    parser.add_argument(
+        "--json-out", type=str, default="dpl-config_train.json", help="train mode: merged JSON configuration"
+    )
+    parser.add_argument(
+        "--train-map", type=str, default="train_outputs.yml", help="train mode: routing of devices to output files"
+    )
+    args = parser.parse_args()
+    list_path_database = args.database
+    debug = args.debug
+    list_workflows_add = [w.split() for w in args.workflows] if args.workflows else []
+    mc_mode = args.mc
+    save_tables = args.tables
+    make_graph = args.graph
+    perf = args.perf
+    list_path_json = args.json if args.json else []
+    train = len(list_path_database) > 1
+
+    # Check the consistency of the per-database arguments.
+    if train:
+        if list_workflows_add and len(list_workflows_add) != len(list_path_database):
+            msg_fatal("Train mode: Provide the workflows (-w) once per database or not at all.")
+        if list_path_json and len(list_path_json) != len(list_path_database):
+            msg_fatal("Train mode: Provide the JSON configuration (-j) once per database or not at all.")
+    elif len(list_workflows_add) > 1:
+        list_workflows_add = [sum(list_workflows_add, [])]
+    if not list_workflows_add:
+        list_workflows_add = [[] for _ in list_path_database]
+
+    if mc_mode:
+        msg_warn("MC mode is on.")
+    if save_tables:
+        msg_warn("Tables will be saved in trees.")
+    if perf:
+        msg_warn(
+            "Performance profiling stats will be saved in perf.data files.\n"
+            "  Convert them with: perf script --demangle -i perf.data --no-inline |"
+            " c++filt -r -t  > profile.linux-perf.txt\n"
+            "  and upload the output to https://www.speedscope.app/."
+        )
+    if train:
+        msg_warn("Train mode is on. Merging %d databases." % len(list_path_database))
+
+    # Activate workflows in each database and merge them into one topology.
+    # Workflows are deduplicated by their executables (i.e. devices), which must have identical options.
+    opt_global, opt_local = "", ""  # options that appear only once, options that appear for each workflow
+    dic_opt_global: dict = {}  # merged global options of train participants
+    dic_opt_local: dict = {}  # merged local options of train participants
+    dic_wf: dict = {}  # activated workflows {name: database entry}
+    dic_exec: dict = {}  # {executable: (name, options, train participant)}
+    tables: List[str] = []  # list of all tables of activated workflows
+    names: List[str] = []  # names of train participants
+    list_dic_wf_db: List[dict] = []  # workflows of train participants
+    conflicts: List[str] = []
+    for path_file_database, workflows_add in zip(list_path_database, list_workflows_add):
+        dic_in = load_database(path_file_database, debug)
+        name = get_train_name(path_file_database, names)
+        names.append(name)
+
+        # Get workflow-independent options.
+        dic_opt = dic_in["options"]
+        opt_global = join_strings(dic_opt["global"])
+        opt_local = join_strings(dic_opt["local"])
+        if train:
+            merge_options(dic_opt_global, opt_global, name, conflicts)
+            merge_options(dic_opt_local, opt_local, name, conflicts)
+
+        # Activate all needed workflows.
+        dic_wf_db = dic_in["workflows"]
+        activate_workflows(dic_wf_db, workflows_add, mc_mode, debug)
+        list_dic_wf_db.append(dic_wf_db)
+        tables += get_tables(dic_wf_db, mc_mode)
+
+        for wf, dic_wf_single in dic_wf_db.items():
+            if not is_activated(dic_wf_single):
                 continue
-            tab_wf = dic_wf_single["tables"]
-            if isinstance(tab_wf, (str, list)):
-                join_to_list(tab_wf, tables)
-            elif isinstance(tab_wf, dict):
-                if "default" in tab_wf:
-                    join_to_list(tab_wf["default"], tables)
-                if not mc_mode and "real" in tab_wf:
-                    join_to_list(tab_wf["real"], tables)
-                if mc_mode and "mc" in tab_wf:
-                    join_to_list(tab_wf["mc"], tables)
-            else:
-                msg_fatal('"tables" in %s must be str, list or dict, is %s' % (wf, type(tab_wf)))
-        string_tables = ",".join(make_table_output(t) for t in tables)
+            exec_wf = get_executable(wf, dic_wf_single)
+            opt_wf = get_workflow_options(wf, dic_wf_single, mc_mode)
+            if train and exec_wf in dic_exec:
+                wf_prev, opt_prev, name_prev = dic_exec[exec_wf]
+                if name_prev == name:
+                    # Keep the single-database behaviour within one participant.
+                    dic_wf[wf] = dic_wf_single
+                elif opt_prev != opt_wf:
+                    conflicts.append(
+                        'Workflow %s: options "%s" (%s: %s) vs "%s" (%s: %s)'
+                        % (exec_wf, opt_prev, name_prev, wf_prev, opt_wf, name, wf)
+                    )
+                elif debug:
+                    eprint("Sharing %s (%s: %s, %s: %s)" % (exec_wf, name_prev, wf_prev, name, wf))
+                continue
+            dic_exec[exec_wf] = (wf, opt_wf, name)
+            dic_wf[wf] = dic_wf_single
+
+    if train:
+        # Options set once for the whole command do not need to be repeated for each workflow.
+        for key in dic_opt_global:
+            dic_opt_local.pop(key, None)
+        opt_global = " ".join(dic_opt_global.values())
+        opt_local = " ".join(dic_opt_local.values())
+        if not list_path_json:
+            msg_warn("No JSON configurations provided. Configuration of shared devices cannot be checked.")
+
+    # Merge the JSON configurations and map devices to output files.
+    if train and list_path_json:
+        dic_json: dict = {}
+        dic_map: dict = {}
+        for name, path_file_json, dic_wf_db in zip(names, list_path_json, list_dic_wf_db):
+            try:
+                with open(path_file_json, "r") as file_json:
+                    dic_json_single = json.load(file_json)
+            except (IOError, ValueError):
+                msg_fatal("Failed to load JSON file " + path_file_json)
+            # Only devices that run for this participant are merged, so conflicts are reported only for shared devices.
+            # Internal devices and devices not attributed to any workflow are merged too, since they may run.
+            devices, devices_unknown = get_activated_devices(dic_wf_db, list(dic_json_single), name)
+            if debug:
+                eprint("\nDevices of %s:" % name)
+                eprint("\n".join("  " + d for d in devices))
+            dic_json_active = {
+                d: v
+                for d, v in dic_json_single.items()
+                if d.startswith("internal-") or d in devices or d in devices_unknown
+            }
+            merge_configurables(dic_json, dic_json_active, "", name, conflicts)
+            dic_map["AnalysisResults_%s.root" % name] = devices
+
+    # Report all conflicts between the train participants at once.
+    if conflicts:
+        msg_err("Conflicting configuration of shared devices:")
+        eprint("\n".join("  " + c for c in conflicts))
+        msg_fatal("Resolve the conflicts in the databases or JSON files before running a train.")
+
+    if train and list_path_json:
+        try:
+            with open(args.json_out, "w") as file_json:
+                json.dump(dic_json, file_json, indent=4)
+            with open(args.train_map, "w") as file_map:
+                yaml.safe_dump(dic_map, file_map, default_flow_style=False)
+        except IOError:
+            msg_fatal("Failed to write the train configuration")
+        eprint("Merged JSON configuration: %s (run the command with JSON=%s)" % (args.json_out, args.json_out))
+        eprint("Routing of outputs: %s (split with split_train_output.py)" % args.train_map)
+
+    # Add the list of tables to the local options.
+    if save_tables:
+        string_tables = ",".join(dict.fromkeys(make_table_output(t) for t in tables))
         if string_tables:
             opt_local += " --aod-writer-keep " + string_tables
 
@@ -258,34 +545,16 @@ def main():
     command = ""
     eprint("\nActivated workflows:")
     for wf, dic_wf_single in dic_wf.items():
-        if "activate" not in dic_wf_single or not dic_wf_single["activate"]:
-            continue
         msg_bold("  " + wf)
         # Determine the workflow executable.
-        if "executable" in dic_wf_single:
-            exec_wf = dic_wf_single["executable"]
-            if not isinstance(exec_wf, str):
-                msg_fatal('"executable" in %s must be str, is %s' % (wf, type(exec_wf)))
-            string_wf = exec_wf
-        else:
-            string_wf = wf
+        string_wf = get_executable(wf, dic_wf_single)
         # Detect duplicate workflows.
         if string_wf + " " in command:
             msg_warn("Workflow %s is already present." % string_wf)
         # Process options.
-        if "options" in dic_wf_single:
-            opt_wf = dic_wf_single["options"]
-            if isinstance(opt_wf, (str, list)):
-                string_wf += " " + join_strings(opt_wf)
-            elif isinstance(opt_wf, dict):
-                if "default" in opt_wf:
-                    string_wf += " " + join_strings(opt_wf["default"])
-                if not mc_mode and "real" in opt_wf:
-                    string_wf += " " + join_strings(opt_wf["real"])
-                if mc_mode and "mc" in opt_wf:
-                    string_wf += " " + join_strings(opt_wf["mc"])
-            else:
-                msg_fatal('"options" in %s must be str, list or dict, is %s' % (wf, type(opt_wf)))
+        opt_wf = get_workflow_options(wf, dic_wf_single, mc_mode)
+        if opt_wf:
+            string_wf += " " + opt_wf
         if opt_local:
             string_wf += " " + opt_local
         command += "| \\\n" + string_wf + " "
@@ -306,7 +575,7 @@ def main():
 
     # Produce topology graph.
     if make_graph:
-        basename, _ = os.path.splitext(path_file_database)
+        basename, _ = os.path.splitext(list_path_database[0] if not train else "train")
         ext_graph = "pdf"
         path_file_dot = basename + ".gv"
         path_file_graph = basename + "." + ext_graph
@@ -317,8 +586,6 @@ def main():
         dot += "  ranksep=2 // vertical node separation\n"
         dot += '  node [shape=box, style="filled,rounded", fillcolor=papayawhip, fontname=Courier, fontsize=20]\n'
         for wf, dic_wf_single in dic_wf.items():
-            if "activate" not in dic_wf_single or not dic_wf_single["activate"]:
-                continue
             # Hyphens are not allowed in node names.
             node_wf = wf.replace("-", "_")
             # Replace hyphens with line breaks to save horizontal space.
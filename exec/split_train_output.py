@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+
+"""
+Splits the output of a train into separate result files.
+The routing of devices to output files is produced by make_command_o2.py in the train mode.
+Top-level directories (devices) not found in the routing are copied into all output files.
+Usage: ./split_train_output.py AnalysisResults.root train_outputs.yml
+"""
+
+import argparse
+import sys
+
+import yaml  # pylint: disable=import-error
+from ROOT import TDirectory, TFile  # pylint: disable=import-error
+
+
+def msg_err(message: str):
+    """Print an error message."""
+    print("\x1b[1;31mError: %s\x1b[0m" % message, file=sys.stderr)
+
+
+def msg_fatal(message: str):
+    """Print an error message and exit."""
+    msg_err(message)
+    sys.exit(1)
+
+
+def msg_warn(message: str):
+    """Print a warning message."""
+    print("\x1b[1;36mWarning:\x1b[0m %s" % message, file=sys.stderr)
+
+
+def copy_directory(dir_in: TDirectory, dir_out: TDirectory):
+    """Copy the content of a directory recursively."""
+    for key in dir_in.GetListOfKeys():
+        obj = key.ReadObj()
+        if obj.InheritsFrom("TDirectory"):
+            dir_sub = dir_out.mkdir(key.GetName())
+            copy_directory(obj, dir_sub)
+        else:
+            dir_out.cd()
+            obj.Write(key.GetName())
+
+
+def main():
+    """Main function"""
+    parser = argparse.ArgumentParser(description="Splits the output of a train into separate result files.")
+    parser.add_argument("input", help="output file of the train")
+    parser.add_argument("routing", help="YAML file with the routing of devices to output files")
+    args = parser.parse_args()
+
+    try:
+        with open(args.routing, "r") as file_routing:
+            dic_map = yaml.safe_load(file_routing)
+    except IOError:
+        msg_fatal("Failed to open file " + args.routing)
+    if not isinstance(dic_map, dict) or not dic_map:
+        msg_fatal("Bad structure of %s" % args.routing)
+
+    file_in = TFile.Open(args.input)
+    if not file_in or file_in.IsZombie():
+        msg_fatal("Failed to open file " + args.input)
+
+    files_out = {name: TFile.Open(name, "RECREATE") for name in dic_map}
+    for key in file_in.GetListOfKeys():
+        name_dev = key.GetName()
+        list_out = [name for name, devices in dic_map.items() if devices and name_dev in devices]
+        if not list_out:
+            msg_warn("Device %s not found in the routing. Copying into all outputs." % name_dev)
+            list_out = list(dic_map)
+        obj = key.ReadObj()
+        for name in list_out:
+            if obj.InheritsFrom("TDirectory"):
+                copy_directory(obj, files_out[name].mkdir(name_dev))
+            else:
+                files_out[name].cd()
+                obj.Write(name_dev)
+    for name, file_out in files_out.items():
+        file_out.Close()
+        print("Written %s" % name)
+    file_in.Close()
+
+
+if __name__ == "__main__":
+    main()